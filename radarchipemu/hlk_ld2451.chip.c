@@ -14,6 +14,8 @@ typedef struct {
 
 typedef struct {
   uart_dev_t uart;
+  timer_t timer;
+  uint16_t report_period_ms;
   target_t targets[MAX_TARGETS];
   uint64_t next_wave_time_ns;
   
@@ -30,6 +32,15 @@ typedef struct {
 const uint8_t CFG_HEADER[] = {0xFD, 0xFC, 0xFB, 0xFA};
 const uint8_t CFG_FOOTER[] = {0x04, 0x03, 0x02, 0x01};
 
+// Command ACK: header, length 4, command | 0x0100, status (0 = success), footer
+static void send_ack(chip_state_t *chip, uint16_t cmd, bool ok) {
+    uint16_t ack_cmd = cmd | 0x0100;
+    uint8_t ack[] = {0xFD, 0xFC, 0xFB, 0xFA, 0x04, 0x00,
+                     ack_cmd & 0xFF, ack_cmd >> 8, ok ? 0x00 : 0x01, 0x00,
+                     0x04, 0x03, 0x02, 0x01};
+    uart_write(chip->uart, ack, sizeof(ack));
+}
+
 static void process_command(chip_state_t *chip) {
     uint16_t cmd = chip->rx_buffer[6] | (chip->rx_buffer[7] << 8);
 
@@ -63,6 +74,20 @@ static void process_command(chip_state_t *chip) {
                 printf("[RADAR] UPDATE -> Sensitivity: %d\n", chip->sensitivity);
             }
             break;
+
+        case 0x0010: {
+            // Acknowledged, so the firmware only switches its rate once the radar has
+            uint16_t period = chip->rx_buffer[8] | (chip->rx_buffer[9] << 8);
+            bool ok = chip->config_enabled && period >= 20 && period <= 1000;
+            if (ok) {
+                chip->report_period_ms = period;
+                timer_stop(chip->timer);
+                timer_start(chip->timer, (uint32_t)period * 1000, true);
+                printf("[RADAR] UPDATE -> Report period: %dms (%dHz)\n", period, 1000 / period);
+            }
+            send_ack(chip, cmd, ok);
+            break;
+        }
     }
 }
 
@@ -84,6 +109,7 @@ static void on_timer(void *user_data) {
 
   uint64_t now_ns = get_sim_nanos();
   int active_count = 0;
+  float dt = chip->report_period_ms / 1000.0f; // seconds per report
 
   if (now_ns > chip->next_wave_time_ns) {
     int num_to_spawn = 1 + (rand() % 3); 
@@ -133,11 +159,11 @@ static void on_timer(void *user_data) {
       if (chip->targets[i].distance < 30.0f) {
         float target_speed_mps = 25.0f / 3.6f; 
         if (chip->targets[i].speed_mps > target_speed_mps) {
-            chip->targets[i].speed_mps -= (1.5f * 0.1f); // Decelerate at 1.5 m/s^2
+            chip->targets[i].speed_mps -= (1.5f * dt); // Decelerate at 1.5 m/s^2
         }
       }
 
-      chip->targets[i].distance -= (chip->targets[i].speed_mps * 0.1f);
+      chip->targets[i].distance -= (chip->targets[i].speed_mps * dt);
 
       // Passing logic: If a car is between 12m and 2m, simulate it veering out to the left (angle < 128)
       if (chip->targets[i].distance <= 12.0f && chip->targets[i].distance > 2.0f) {
@@ -149,7 +175,7 @@ static void on_timer(void *user_data) {
             chip->targets[i].angle = 128.0f; // Stay in line
         }
 
-        chip->targets[i].distance -= (chip->targets[i].speed_mps * 0.1f);
+        chip->targets[i].distance -= (chip->targets[i].speed_mps * dt);
 
       if (chip->targets[i].distance <= 0.5f) {
         chip->targets[i].active = false;
@@ -190,6 +216,7 @@ void chip_init(void) {
     .rx_data = on_uart_data,
   };
   chip->uart = uart_init(&uart_config);
+  chip->report_period_ms = 100;
   chip->config_enabled = false;
   chip->direction_filter = 1;
   chip->max_distance = 100;
@@ -200,6 +227,6 @@ void chip_init(void) {
   for (int i = 0; i < MAX_TARGETS; i++) chip->targets[i].active = false;
   chip->next_wave_time_ns = get_sim_nanos() + 1000000000;
   const timer_config_t timer_config = { .user_data = chip, .callback = on_timer };
-  timer_t timer_id = timer_init(&timer_config);
-  timer_start(timer_id, 100000, true); 
+  chip->timer = timer_init(&timer_config);
+  timer_start(chip->timer, (uint32_t)chip->report_period_ms * 1000, true); 
 }
@@ -0,0 +1,167 @@
+#ifndef ALLOC_TRACE_H
+#define ALLOC_TRACE_H
+
+#include <Arduino.h>
+
+// Where a heap allocation happened. LOOP is the whole of loop(); each handler
+// site covers one whole web handler body (AllocScope), including the web
+// server's per-request objects, so it never reads zero; compare it against the
+// call count. NET is everything else on the other tasks (WiFi, lwIP, AsyncTCP).
+enum AllocSite : uint8_t {
+    ALLOC_SITE_NET,
+    ALLOC_SITE_LOOP,
+    ALLOC_SITE_DATA,
+    ALLOC_SITE_CONFIG,
+    ALLOC_SITE_PROFILE,
+    ALLOC_SITE_YOLO,
+    ALLOC_SITE_HISTORY,
+    ALLOC_SITE_MIRROR,
+    ALLOC_SITE_COUNT
+};
+
+#ifdef ALLOC_TRACE
+
+#include <atomic>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+// Build with the esp32dev-alloctrace env: the linker routes malloc/calloc/
+// realloc/free through the __wrap_ hooks below once setup() has finished.
+// --wrap only rewrites calls to those symbols: newlib's reentrant _malloc_r
+// (float printf, stdio buffers) and IDF code calling heap_caps_malloc directly
+// bypass it, so those allocations are not counted anywhere.
+extern "C" {
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t n, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+void __real_free(void *ptr);
+}
+
+class AllocTrace {
+private:
+    static const char *siteName(int site) {
+        static const char *const NAMES[ALLOC_SITE_COUNT] = {
+            "net", "loop", "data", "config", "profile", "yolo", "history", "mirror"
+        };
+        return NAMES[site];
+    }
+
+public:
+    static std::atomic<bool> armed;
+    static TaskHandle_t loopTask;
+    static volatile uint8_t handlerSite; // Set by AllocScope on the web task
+    static volatile TaskHandle_t handlerTask;
+    static std::atomic<uint32_t> allocs[ALLOC_SITE_COUNT];
+    static std::atomic<uint32_t> calls[ALLOC_SITE_COUNT]; // AllocScopes entered
+    static std::atomic<uint32_t> frees;
+    static void *volatile lastCaller[ALLOC_SITE_COUNT];
+    static volatile int failedSite;
+
+    // Called at the end of setup(); the calling task is the loop task
+    static void arm() {
+        loopTask = xTaskGetCurrentTaskHandle();
+        armed.store(true);
+    }
+
+    static void count(void *caller) {
+        if (!armed.load(std::memory_order_relaxed)) return;
+        TaskHandle_t task = xTaskGetCurrentTaskHandle();
+        int site = ALLOC_SITE_NET;
+        if (task == loopTask) site = ALLOC_SITE_LOOP;
+        else if (task == handlerTask) site = handlerSite;
+        allocs[site].fetch_add(1, std::memory_order_relaxed);
+        lastCaller[site] = caller;
+#ifdef ALLOC_TRACE_STRICT
+        // Handlers always pay the web server's per-request floor, so only loop() is fatal
+        if (site == ALLOC_SITE_LOOP && failedSite < 0) failedSite = site;
+#endif
+    }
+
+    // Loop-side check for ALLOC_TRACE_STRICT builds: report and abort on the
+    // first allocation in loop() (the malloc hook itself must not print)
+    static void check() {
+        int site = failedSite;
+        if (site < 0) return;
+        Serial.printf("[ALLOC] FAIL: %s allocated, caller %p\n", siteName(site), lastCaller[site]);
+        Serial.flush();
+        abort();
+    }
+
+    static void report(Print &out) {
+        out.print("[ALLOC]");
+        for (int i = 0; i < ALLOC_SITE_COUNT; i++) {
+            out.printf(" %s=%lu", siteName(i), (unsigned long)allocs[i].load());
+            if (i > ALLOC_SITE_LOOP) out.printf("/%lu", (unsigned long)calls[i].load());
+            if (i != ALLOC_SITE_NET && allocs[i].load() > 0) out.printf("(%p)", lastCaller[i]);
+        }
+        out.printf(" frees=%lu\n", (unsigned long)frees.load());
+    }
+};
+
+std::atomic<bool> AllocTrace::armed(false);
+TaskHandle_t AllocTrace::loopTask = nullptr;
+volatile uint8_t AllocTrace::handlerSite = ALLOC_SITE_NET;
+volatile TaskHandle_t AllocTrace::handlerTask = nullptr;
+std::atomic<uint32_t> AllocTrace::allocs[ALLOC_SITE_COUNT];
+std::atomic<uint32_t> AllocTrace::calls[ALLOC_SITE_COUNT];
+std::atomic<uint32_t> AllocTrace::frees(0);
+void *volatile AllocTrace::lastCaller[ALLOC_SITE_COUNT];
+volatile int AllocTrace::failedSite = -1;
+
+extern "C" {
+void *__wrap_malloc(size_t size) {
+    AllocTrace::count(__builtin_return_address(0));
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t n, size_t size) {
+    AllocTrace::count(__builtin_return_address(0));
+    return __real_calloc(n, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size) {
+    AllocTrace::count(__builtin_return_address(0));
+    return __real_realloc(ptr, size);
+}
+
+void __wrap_free(void *ptr) {
+    if (ptr && AllocTrace::armed.load(std::memory_order_relaxed)) {
+        AllocTrace::frees.fetch_add(1, std::memory_order_relaxed);
+    }
+    __real_free(ptr);
+}
+}
+
+// Attributes allocations on the web task to one of our handlers while in scope.
+// Filler callbacks and the mirror pump open their own scope, so a streamed
+// response counts one call per chunk (or ack/poll) as well as one for the request.
+class AllocScope {
+private:
+    uint8_t _prev;
+
+public:
+    explicit AllocScope(AllocSite site) : _prev(AllocTrace::handlerSite) {
+        AllocTrace::handlerTask = xTaskGetCurrentTaskHandle();
+        AllocTrace::handlerSite = site;
+        AllocTrace::calls[site].fetch_add(1, std::memory_order_relaxed);
+    }
+    ~AllocScope() { AllocTrace::handlerSite = _prev; }
+};
+
+#else
+
+class AllocTrace {
+public:
+    static void arm() {}
+    static void check() {}
+    static void report(Print &) {}
+};
+
+class AllocScope {
+public:
+    explicit AllocScope(AllocSite) {}
+};
+
+#endif
+
+#endif
@@ -0,0 +1,91 @@
+#ifndef CONTROL_MAILBOX_H
+#define CONTROL_MAILBOX_H
+
+#include <atomic>
+#include "RadarConfig.h"
+
+// Full radar parameter set, always sent to the main loop as one message
+struct RadarSettings {
+    uint8_t range;
+    uint8_t direction;
+    uint8_t minSpeed;
+    uint8_t sensitivity;
+    uint8_t rateHz;
+};
+
+enum RadarProfile : uint8_t { PROFILE_CITY, PROFILE_HIGHWAY };
+
+enum ControlCommandType : uint8_t {
+    CMD_CONFIG,       // Replace the radar parameter set
+    CMD_PROFILE,      // Apply a city/highway preset on top of the current set
+    CMD_VETO,         // YOLO feedback from the phone
+    CMD_TRAFFIC_SIDE  // Left/right hand traffic for the display
+};
+
+struct ControlCommand {
+    ControlCommandType type;
+    union {
+        RadarSettings config;
+        RadarProfile profile;
+        bool vetoActive;
+        TrafficSide side;
+    };
+};
+
+// Bounded lock-free queue (Vyukov's per-slot sequence scheme) carrying commands
+// from the async web handlers to loop(). A command is only visible to the consumer
+// once its slot is fully written, so a reader can never see half a parameter set.
+// Any number of producers may push; loop() is the only consumer.
+template <size_t N>
+class ControlMailbox {
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "Mailbox size must be a power of two");
+
+private:
+    struct Slot {
+        std::atomic<uint32_t> seq;
+        ControlCommand cmd;
+    };
+
+    Slot _slots[N];
+    std::atomic<uint32_t> _head; // Next slot to write
+    std::atomic<uint32_t> _tail; // Next slot to read
+
+public:
+    ControlMailbox() : _head(0), _tail(0) {
+        for (size_t i = 0; i < N; i++) _slots[i].seq.store(i, std::memory_order_relaxed);
+    }
+
+    // Returns false (command rejected, not dropped silently) when the queue is full
+    bool push(const ControlCommand &cmd) {
+        uint32_t pos = _head.load(std::memory_order_relaxed);
+        for (;;) {
+            Slot &slot = _slots[pos & (N - 1)];
+            int32_t diff = (int32_t)(slot.seq.load(std::memory_order_acquire) - pos);
+            if (diff == 0) {
+                if (_head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    slot.cmd = cmd;
+                    slot.seq.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = _head.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool pop(ControlCommand &out) {
+        uint32_t pos = _tail.load(std::memory_order_relaxed);
+        Slot &slot = _slots[pos & (N - 1)];
+        int32_t diff = (int32_t)(slot.seq.load(std::memory_order_acquire) - (pos + 1));
+        if (diff != 0) return false; // Empty, or the producer has not finished writing yet
+
+        out = slot.cmd;
+        slot.seq.store(pos + N, std::memory_order_release);
+        _tail.store(pos + 1, std::memory_order_relaxed);
+        return true;
+    }
+};
+
+#endif
@@ -0,0 +1,87 @@
+#ifndef DATA_CACHE_H
+#define DATA_CACHE_H
+
+#include <atomic>
+#include "RadarConfig.h"
+
+#define DATA_CACHE_SLOTS 4       // Power of two: the slot index lives in the low bits of _current
+#define DATA_CACHE_BYTES 256
+
+// /data body, serialized once per decoded frame by loop() and served as-is to
+// every poller. The sequence only moves when the JSON actually changes, so it
+// doubles as the ETag (behind the per-boot tag the /data handler adds).
+// A 200 response sends straight from its slot, possibly over several TCP acks,
+// so the handler pins the slot until the connection closes. publish() never
+// rewrites a pinned slot; with every spare slot pinned it keeps the current body
+// and retries on the next frame instead of waiting.
+class DataCache {
+    static_assert((DATA_CACHE_SLOTS & (DATA_CACHE_SLOTS - 1)) == 0, "Slot count must be a power of two");
+
+private:
+    static const uint32_t SLOT_MASK = DATA_CACHE_SLOTS - 1;
+    static const int SEQ_SHIFT = __builtin_ctz(DATA_CACHE_SLOTS);
+
+    char _slots[DATA_CACHE_SLOTS][DATA_CACHE_BYTES];
+    size_t _len[DATA_CACHE_SLOTS] = {0};
+    std::atomic<uint8_t> _pins[DATA_CACHE_SLOTS]; // Responses still sending from each slot
+    std::atomic<uint32_t> _current;               // (seq << SEQ_SHIFT) | slot
+
+    static size_t serialize(char *buf, int count, const RadarTarget *targets) {
+        size_t len = snprintf(buf, DATA_CACHE_BYTES, "{\"status\":\"online\",\"count\":%d,\"targets\":[", count);
+        for (int i = 0; i < count; i++) {
+            len += snprintf(buf + len, DATA_CACHE_BYTES - len, "%s{\"id\":%d,\"dist\":%u}",
+                            (i > 0) ? "," : "", i, targets[i].distance);
+        }
+        len += snprintf(buf + len, DATA_CACHE_BYTES - len, "]}");
+        return len;
+    }
+
+public:
+    DataCache() : _current(0) {
+        for (int i = 0; i < DATA_CACHE_SLOTS; i++) _pins[i].store(0, std::memory_order_relaxed);
+        _len[0] = serialize(_slots[0], 0, nullptr);
+    }
+
+    // Main loop only
+    void publish(int count, const RadarTarget *targets) {
+        uint32_t cur = _current.load(std::memory_order_relaxed);
+        int curSlot = cur & SLOT_MASK;
+        int next = -1;
+        for (int k = 1; k < DATA_CACHE_SLOTS && next < 0; k++) {
+            int s = (curSlot + k) & SLOT_MASK;
+            if (_pins[s].load() == 0) next = s;
+        }
+        if (next < 0) return; // Every spare slot is still being sent
+
+        size_t len = serialize(_slots[next], count, targets);
+        if (len == _len[curSlot] && memcmp(_slots[next], _slots[curSlot], len) == 0) return;
+
+        _len[next] = len;
+        _current.store((((cur >> SEQ_SHIFT) + 1) << SEQ_SHIFT) | next);
+    }
+
+    // Web task: pins the newest body and returns its sequence; every call must
+    // be paired with release(slot). A slot is only ever rewritten after it has
+    // stopped being current, so re-checking _current after pinning (both
+    // seq_cst, against publish() storing _current before it checks the pins)
+    // guarantees publish() sees the pin before it can pick this slot.
+    uint32_t acquire(const char *&body, size_t &len, int &slot) {
+        for (;;) {
+            uint32_t cur = _current.load();
+            slot = cur & SLOT_MASK;
+            _pins[slot].fetch_add(1);
+            if (_current.load() == cur) {
+                body = _slots[slot];
+                len = _len[slot];
+                return cur >> SEQ_SHIFT;
+            }
+            _pins[slot].fetch_sub(1); // Moved on meanwhile, pin the new one
+        }
+    }
+
+    void release(int slot) {
+        _pins[slot].fetch_sub(1, std::memory_order_release);
+    }
+};
+
+#endif
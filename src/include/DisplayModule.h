@@ -4,20 +4,90 @@
 #include <Adafruit_GFX.h>
 #include <Adafruit_SSD1306.h>
 #include "RadarConfig.h"
+#include "MirrorCache.h"
 
 class DisplayModule {
+public:
+    static const int WIDTH = 128;
+    static const int HEIGHT = 64;
+    static const int FRAME_BYTES = WIDTH * HEIGHT / 8;
+    static_assert(FRAME_BYTES == MIRROR_FRAME_BYTES, "Mirror must match the panel");
+
 private:
     Adafruit_SSD1306 _display;
 
+    // Completed frames for the HTTP mirror. render() builds the next frame in
+    // place (background first, sprites after), so the web task never reads the
+    // live buffer, only the BMP parts present() publishes here.
+    MirrorCache _mirror;
+
+    // Road position at the FAR RIGHT, and where "OK"/"--" goes after "PHONE:"
+    static const int ROAD_X = 120;
+    static const int PHONE_STATE_X = 36;
+
+    // Static layer drawn once in init() and copied in as the base of each frame
+    uint8_t _background[FRAME_BYTES];
+
+    // Projection tables over the whole uint8 range, filled with the same map()
+    // calls render() used to make per target, so the output is unchanged
+    uint8_t _carY[256];      // distance -> dot Y
+    int8_t _barWidth[256];   // distance -> bar length
+    int16_t _carX[2][256];   // [right, left hand traffic][angle] -> dot X
+
+    void buildLayers() {
+        for (int v = 0; v < 256; v++) {
+            _carY[v] = map(v, 0, 100, 15, 64);
+            _barWidth[v] = map(v, 0, 100, 50, 0);
+
+            // Map Angle 128 (Center) to 0 offset. 
+            // Angle 80 (Passing) will map to a negative offset (Left)
+            // We increase the range to -80 to 80 for a wider "lane" feel
+            int xOffset = map(v, 0, 255, -80, 80);
+            _carX[0][v] = ROAD_X + xOffset;
+            _carX[1][v] = ROAD_X - xOffset;
+        }
+
+        _display.clearDisplay();
+        _display.setTextSize(1);
+        _display.setTextColor(WHITE);
+        _display.setCursor(0, 0);
+        _display.print("PHONE:");
+        _display.drawLine(ROAD_X, 64, ROAD_X, 11, WHITE); 
+        _display.fillTriangle(ROAD_X - 3, 10, ROAD_X + 3, 10, ROAD_X, 5, WHITE); 
+        memcpy(_background, _display.getBuffer(), FRAME_BYTES);
+    }
+
+    // Blinking REC Icon (Top Middle)
+    void drawRecIcon(bool isRecording) {
+        if (isRecording) {
+            // Blink every 500ms
+            if ((millis() / 500) % 2 == 0) {
+                _display.fillCircle(70, 3, 3, WHITE);
+                _display.setCursor(76, 0);
+                _display.print("REC");
+            }
+        }
+    }
+
+    // Push the buffer to the panel and publish it to the mirror if it changed
+    void present() {
+        _mirror.publish(_display.getBuffer());
+        _display.display();
+    }
+
 public:
-    DisplayModule() : _display(128, 64, &Wire, -1) {}
+    DisplayModule() : _display(WIDTH, HEIGHT, &Wire, -1) {}
 
     void init() {
         if(!_display.begin(SSD1306_SWITCHCAPVCC, 0x3C)) Serial.println("OLED Fail");
+        buildLayers();
         _display.clearDisplay();
-        _display.display();
+        present();
     }
 
+    // Ready-to-send mirror parts, read by the web task
+    MirrorCache &mirror() { return _mirror; }
+
     // Helper to draw the status bar at the top
     void drawStatusBar(bool phoneConnected, bool isRecording) {
         _display.setTextSize(1);
@@ -31,49 +101,34 @@ public:
             _display.print("PHONE:--");
         }
 
-        // Blinking REC Icon (Top Middle)
-        if (isRecording) {
-            // Blink every 500ms
-            if ((millis() / 500) % 2 == 0) {
-                _display.fillCircle(70, 3, 3, WHITE);
-                _display.setCursor(76, 0);
-                _display.print("REC");
-            }
-        }
+        drawRecIcon(isRecording);
     }
 
     void render(int count, RadarTarget *targets, bool phoneConnected, bool isRecording) {
-        _display.clearDisplay();
-        drawStatusBar(phoneConnected, isRecording);
+        // 1. Static layer (road, bike, "PHONE:" label) as the base of the frame
+        memcpy(_display.getBuffer(), _background, FRAME_BYTES);
 
-        // 1. Position road to the FAR RIGHT
-        int roadX = 120;
-        _display.drawLine(roadX, 64, roadX, 11, WHITE); 
-        _display.fillTriangle(roadX - 3, 10, roadX + 3, 10, roadX, 5, WHITE); 
+        // 2. Dynamic status text
+        _display.setTextSize(1);
+        _display.setTextColor(WHITE);
+        _display.setCursor(PHONE_STATE_X, 0);
+        _display.print(phoneConnected ? "OK" : "--");
+        drawRecIcon(isRecording);
 
+        const int16_t *carX = _carX[currentTrafficSide == LEFT_HAND_DRIVE ? 1 : 0];
         for (int i = 0; i < count; i++) {
-            int yPos = map(targets[i].distance, 0, 100, 15, 64);
-            
-            // 2. Map Angle 128 (Center) to 0 offset. 
-            // Angle 80 (Passing) will map to a negative offset (Left)
-            // We increase the range to -50 to 50 for a wider "lane" feel
-            int xOffset = map(targets[i].angle, 0, 255, -80, 80);
-            
-            if (currentTrafficSide == LEFT_HAND_DRIVE) {
-                xOffset = -xOffset;
-            }
+            uint8_t dist = targets[i].distance;
 
             // Draw Car Dot
-            _display.fillCircle(roadX + xOffset, yPos, 2, WHITE); 
+            _display.fillCircle(carX[targets[i].angle], _carY[dist], 2, WHITE); 
             
             // 3. Distance Bars (Shifted slightly right to fit)
-            int barWidth = map(targets[i].distance, 0, 100, 50, 0);
-            _display.fillRect(10, 15 + (i * 12), barWidth, 8, WHITE);
+            _display.fillRect(10, 15 + (i * 12), _barWidth[dist], 8, WHITE);
             
             _display.setCursor(65, 15 + (i * 12));
-            _display.print(targets[i].distance); _display.print("m");
+            _display.print(dist); _display.print("m");
         }
-        _display.display();
+        present();
     }
     
     void showClear(bool phoneConnected) {
@@ -81,7 +136,7 @@ public:
         drawStatusBar(phoneConnected, false);
         _display.setCursor(35, 30);
         _display.print("ROAD CLEAR");
-        _display.display();
+        present();
     }
 };
 
@@ -3,11 +3,15 @@
 
 #include <Arduino.h>
 
-#define FILTER_WINDOW 6 // Smooth over the last 6 frames
+// Smooth over the last 6 frames. The window is a frame count on purpose: at a
+// higher report rate it spans less time (600ms at 10Hz, 120ms at 50Hz), which is
+// where the faster alerts come from.
+#define FILTER_WINDOW 6
 
 class SignalFilter {
 private:
-    float _history[5][FILTER_WINDOW]; // 5 targets, 3 frames each
+    float _history[5][FILTER_WINDOW]; // 5 targets, 6 frames each
+    float _sum[5] = {0, 0, 0, 0, 0};  // Running sum so each sample is O(1)
     int _index[5] = {0, 0, 0, 0, 0};
     bool _isInitialized[5] = {false, false, false, false, false}; 
 
@@ -20,24 +24,22 @@ public:
             for (int i = 0; i < FILTER_WINDOW; i++) {
                 _history[targetId][i] = newDist;
             }
+            _sum[targetId] = newDist * FILTER_WINDOW;
             _isInitialized[targetId] = true;
             return newDist;
         }
-        // Add to circular buffer
+        // Add to circular buffer, swapping the oldest sample out of the sum
+        _sum[targetId] += newDist - _history[targetId][_index[targetId]];
         _history[targetId][_index[targetId]] = newDist;
         _index[targetId] = (_index[targetId] + 1) % FILTER_WINDOW;
 
-        // Calculate Average
-        float sum = 0;
-        for (int i = 0; i < FILTER_WINDOW; i++) {
-            sum += _history[targetId][i];
-        }
-        return sum / FILTER_WINDOW;
+        return _sum[targetId] / FILTER_WINDOW;
     }
 
     void reset(int targetId) {
         _isInitialized[targetId] = false; 
         _index[targetId] = 0;
+        _sum[targetId] = 0;
         for (int i = 0; i < FILTER_WINDOW; i++) _history[targetId][i] = 0;
     }
 };
@@ -0,0 +1,113 @@
+#ifndef MIRROR_CACHE_H
+#define MIRROR_CACHE_H
+
+#include <atomic>
+#include <Arduino.h>
+
+#define MIRROR_SLOTS 4 // Power of two: the slot index lives in the low bits of _current
+
+static const int MIRROR_WIDTH = 128;
+static const int MIRROR_HEIGHT = 64;
+static const int MIRROR_FRAME_BYTES = MIRROR_WIDTH * MIRROR_HEIGHT / 8;
+
+// Display mirror stream: every multipart part is a 1-bit BMP of the OLED
+static const char MIRROR_PART_HEADER[] =
+    "--frame\r\nContent-Type: image/bmp\r\nContent-Length: 1086\r\n\r\n";
+static const size_t MIRROR_PART_HEADER_LEN = sizeof(MIRROR_PART_HEADER) - 1;
+
+// BITMAPFILEHEADER + BITMAPINFOHEADER + 2 colour palette for a 128x64 1bpp image
+static const uint8_t MIRROR_BMP_HEADER[62] = {
+    'B', 'M', 0x3E, 0x04, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x3E, 0x00, 0x00, 0x00,
+    0x28, 0x00, 0x00, 0x00, 0x80, 0x00, 0x00, 0x00, 0x40, 0x00, 0x00, 0x00, 0x01, 0x00, 0x01, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x04, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0xFF, 0x00
+};
+
+static const size_t MIRROR_PIXELS_OFFSET = MIRROR_PART_HEADER_LEN + sizeof(MIRROR_BMP_HEADER);
+static const size_t MIRROR_PART_LEN = MIRROR_PIXELS_OFFSET + MIRROR_FRAME_BYTES + 2;
+
+// Complete /mjpeg parts (boundary, BMP headers, pixels, CRLF), built once per
+// changed screen by the main loop and sent as-is to every viewer. Slots are
+// pinned while lwIP still references them, exactly like DataCache: publish()
+// never rewrites a pinned slot and skips the frame if every spare one is.
+class MirrorCache {
+    static_assert((MIRROR_SLOTS & (MIRROR_SLOTS - 1)) == 0, "Slot count must be a power of two");
+
+private:
+    static const uint32_t SLOT_MASK = MIRROR_SLOTS - 1;
+    static const int SEQ_SHIFT = __builtin_ctz(MIRROR_SLOTS);
+
+    uint8_t _parts[MIRROR_SLOTS][MIRROR_PART_LEN];
+    std::atomic<uint8_t> _pins[MIRROR_SLOTS]; // Viewers still sending each slot
+    std::atomic<uint32_t> _current;           // (seq << SEQ_SHIFT) | slot
+
+    // SSD1306 page layout (8 vertical pixels per byte, LSB on top) to
+    // bottom-up BMP rows, MSB leftmost
+    static void transpose(const uint8_t *fb, uint8_t *px) {
+        for (int row = 0; row < MIRROR_HEIGHT; row++) {
+            int y = MIRROR_HEIGHT - 1 - row;
+            const uint8_t *page = fb + (y >> 3) * MIRROR_WIDTH;
+            uint8_t bit = y & 7;
+            for (int x = 0; x < MIRROR_WIDTH; x += 8) {
+                uint8_t out = 0;
+                for (int k = 0; k < 8; k++) {
+                    out = (out << 1) | ((page[x + k] >> bit) & 0x01);
+                }
+                *px++ = out;
+            }
+        }
+    }
+
+public:
+    MirrorCache() : _current(0) {
+        for (int i = 0; i < MIRROR_SLOTS; i++) {
+            _pins[i].store(0, std::memory_order_relaxed);
+            uint8_t *part = _parts[i];
+            memcpy(part, MIRROR_PART_HEADER, MIRROR_PART_HEADER_LEN);
+            memcpy(part + MIRROR_PART_HEADER_LEN, MIRROR_BMP_HEADER, sizeof(MIRROR_BMP_HEADER));
+            memset(part + MIRROR_PIXELS_OFFSET, 0, MIRROR_FRAME_BYTES);
+            part[MIRROR_PART_LEN - 2] = '\r';
+            part[MIRROR_PART_LEN - 1] = '\n';
+        }
+    }
+
+    // Main loop only. Converts the frame straight into a spare slot (the only
+    // pass over it) and publishes that slot if the picture changed.
+    void publish(const uint8_t *fb) {
+        uint32_t cur = _current.load(std::memory_order_relaxed);
+        int curSlot = cur & SLOT_MASK;
+        int next = -1;
+        for (int k = 1; k < MIRROR_SLOTS && next < 0; k++) {
+            int s = (curSlot + k) & SLOT_MASK;
+            if (_pins[s].load() == 0) next = s;
+        }
+        if (next < 0) return; // Every spare slot is still being sent
+
+        uint8_t *px = _parts[next] + MIRROR_PIXELS_OFFSET;
+        transpose(fb, px);
+        if (memcmp(px, _parts[curSlot] + MIRROR_PIXELS_OFFSET, MIRROR_FRAME_BYTES) == 0) return;
+
+        _current.store((((cur >> SEQ_SHIFT) + 1) << SEQ_SHIFT) | next);
+    }
+
+    // Web task: pins the newest part and returns its sequence; pair every call
+    // with release(slot). Same publication protocol as DataCache::acquire().
+    uint32_t acquire(int &slot) {
+        for (;;) {
+            uint32_t cur = _current.load();
+            slot = cur & SLOT_MASK;
+            _pins[slot].fetch_add(1);
+            if (_current.load() == cur) return cur >> SEQ_SHIFT;
+            _pins[slot].fetch_sub(1); // Moved on meanwhile, pin the new one
+        }
+    }
+
+    const uint8_t *part(int slot) const { return _parts[slot]; }
+
+    void release(int slot) {
+        _pins[slot].fetch_sub(1, std::memory_order_release);
+    }
+};
+
+#endif
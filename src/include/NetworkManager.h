@@ -4,106 +4,415 @@
 #include <WiFi.h>
 #include <ESPAsyncWebServer.h>
 #include "RadarConfig.h"
+#include "DisplayModule.h"
+#include "ControlMailbox.h"
+#include "TrackHistory.h"
+#include "AllocTrace.h"
+#include "DataCache.h"
 
-extern volatile int globalTargetCount;
-extern bool yoloVetoActive; // Global flag to kill alerts
-extern volatile float lastVetoDistance;
-extern RadarTarget activeTargets[];
-extern bool pendingConfigChange;
-extern uint8_t nextRange, nextDir, nextMinSpd, nextSens;
+extern DataCache dataCache;
+extern ControlMailbox<16> controlMailbox; // Only way handlers talk to loop()
+extern DisplayModule ui;
+extern TrackHistory trackHistory;
 
 
+#define MIRROR_MAX_CLIENTS 4
+
+#define DATA_MAX_CLIENTS 8
+#define DATA_MIN_INTERVAL_MS 100 // Per-client cap on full /data bodies (10Hz)
+
 class NetworkManager {
 private:
     AsyncWebServer _server;
 
+    // One /mjpeg viewer. After the HTTP head the connection is taken over from
+    // the web server and fed whole parts straight out of the MirrorCache: add()
+    // without the copy flag makes lwIP reference the slot, so it stays pinned
+    // until every byte of the part has been acked.
+    struct MirrorClient {
+        AsyncClient *client = nullptr; // nullptr = free
+        bool started = false;
+        uint32_t seq = 0;              // Part being (or last) sent
+        int slot = -1;                 // Pinned while >= 0
+        size_t queued = 0;             // Bytes of the part handed to lwIP
+        size_t unacked = 0;
+    };
+    static MirrorClient _mirrorClients[MIRROR_MAX_CLIENTS];
+
+    // Queues as much as the TCP window takes and moves on to the next frame once
+    // a part is fully acked. Runs on the async_tcp task from onAck and onPoll; a
+    // viewer that is waiting for a new frame is only polled every ~500ms, so the
+    // first frame after the screen has been idle can arrive that late.
+    static void mirrorPump(MirrorClient &mc) {
+        AllocScope scope(ALLOC_SITE_MIRROR);
+        MirrorCache &cache = ui.mirror();
+        for (;;) {
+            if (mc.slot < 0) {
+                int slot;
+                uint32_t seq = cache.acquire(slot);
+                if (mc.started && seq == mc.seq) {
+                    cache.release(slot); // Nothing new on screen
+                    return;
+                }
+                mc.seq = seq;
+                mc.slot = slot;
+                mc.started = true;
+                mc.queued = 0;
+            }
+            if (mc.queued < MIRROR_PART_LEN) {
+                size_t n = MIRROR_PART_LEN - mc.queued;
+                size_t space = mc.client->space();
+                if (n > space) n = space;
+                if (n == 0) return;
+                size_t added = mc.client->add((const char *)cache.part(mc.slot) + mc.queued, n, 0);
+                if (added == 0) return;
+                mc.queued += added;
+                mc.unacked += added;
+                mc.client->send();
+                if (mc.queued < MIRROR_PART_LEN) return; // Window full, resume on ack
+            }
+            if (mc.unacked > 0) return; // lwIP still references the slot
+            cache.release(mc.slot);
+            mc.slot = -1;
+        }
+    }
+
+    static void startMirror(int idx, AsyncWebServerRequest *request) {
+        MirrorClient &mc = _mirrorClients[idx];
+        AsyncClient *c = request->client();
+        mc = MirrorClient();
+        mc.client = c;
+
+        c->setRxTimeout(0);
+        c->onError(nullptr, nullptr);
+        c->onData(nullptr, nullptr);
+        c->onAck([](void *arg, AsyncClient *, size_t len, uint32_t) {
+            MirrorClient &mc = *(MirrorClient *)arg;
+            mc.unacked = (len < mc.unacked) ? mc.unacked - len : 0;
+            mirrorPump(mc);
+        }, &mc);
+        c->onPoll([](void *arg, AsyncClient *) { mirrorPump(*(MirrorClient *)arg); }, &mc);
+        c->onTimeout([](void *, AsyncClient *c, uint32_t) { c->close(); }, nullptr);
+        c->onDisconnect([](void *arg, AsyncClient *c) {
+            MirrorClient &mc = *(MirrorClient *)arg;
+            if (mc.slot >= 0) ui.mirror().release(mc.slot); // The pcb is gone, nothing references it
+            mc = MirrorClient();
+            delete c; // Owned by whoever holds the connection, which is now us
+        }, &mc);
+
+        // Same hand-over as AsyncEventSource: the request (and its response) go
+        // away here, the connection stays
+        delete request;
+        mirrorPump(mc);
+    }
+
+    // Sends the multipart head through the web server, then hands the
+    // connection to startMirror() once the head is acked
+    class MirrorResponse : public AsyncWebServerResponse {
+    private:
+        int _idx;
+
+    public:
+        explicit MirrorResponse(int idx) : _idx(idx) {
+            _code = 200;
+            _contentType = "multipart/x-mixed-replace; boundary=frame";
+            _sendContentLength = false;
+            addHeader("Cache-Control", "no-cache");
+        }
+
+        bool _sourceValid() const override { return true; }
+
+        void _respond(AsyncWebServerRequest *request) override {
+            String head = _assembleHead(request->version());
+            request->client()->write(head.c_str(), _headLength);
+            _state = RESPONSE_WAIT_ACK;
+        }
+
+        size_t _ack(AsyncWebServerRequest *request, size_t len, uint32_t time) override {
+            (void)time;
+            _ackedLength += len;
+            if (_ackedLength >= _headLength) startMirror(_idx, request); // Deletes this
+            return 0;
+        }
+    };
+
     //Helper to send commands to radar (if needed in future)
     void sendRadarCommand(uint8_t* cmd, size_t len) {
         Serial2.write(cmd, len);
         delay(60); // Small delay to ensure radar has time to process command before next one arrives
     }
 
+    // Per-connection cursor of a /history stream; 'line' holds the piece of
+    // JSON currently being copied out, since a row may straddle two chunks
+    struct HistoryStream {
+        HistoryCursor cursor;
+        uint32_t now = 0;
+        uint8_t stage = 0; // 0 header, 1 rows, 2 footer, 3 done
+        bool firstRow = true;
+        char line[48];
+        uint8_t lineLen = 0;
+        uint8_t lineOff = 0;
+    };
+
+    static size_t fillHistory(HistoryStream &st, uint8_t *buffer, size_t maxLen) {
+        size_t written = 0;
+        while (written < maxLen) {
+            if (st.lineOff >= st.lineLen) {
+                int len = 0;
+                HistorySample s;
+                if (st.stage == 0) {
+                    len = snprintf(st.line, sizeof(st.line), "{\"now\":%lu,\"step\":%lu,\"samples\":[",
+                                   (unsigned long)st.now, (unsigned long)st.cursor.step);
+                    st.stage = 1;
+                } else if (st.stage == 1 && trackHistory.next(st.cursor, s) &&
+                           (int32_t)(s.time - st.now) < 0) {
+                    // Rows recorded while this response is being sent belong to the
+                    // next poll (since = now), so the stream stops at 'now'
+                    len = snprintf(st.line, sizeof(st.line), "%s[%lu,%u,%u,%u,%u]", st.firstRow ? "" : ",",
+                                   (unsigned long)s.time, s.distance, s.speed, s.angle, s.count);
+                    st.firstRow = false;
+                } else if (st.stage <= 2) {
+                    len = snprintf(st.line, sizeof(st.line), "]}");
+                    st.stage = 3;
+                } else {
+                    break;
+                }
+                // snprintf returns the untruncated length; never copy past 'line'
+                if (len < 0) len = 0;
+                if (len > (int)sizeof(st.line) - 1) len = sizeof(st.line) - 1;
+                st.lineLen = (uint8_t)len;
+                st.lineOff = 0;
+            }
+            size_t n = st.lineLen - st.lineOff;
+            if (n > maxLen - written) n = maxLen - written;
+            memcpy(buffer + written, st.line + st.lineOff, n);
+            st.lineOff += n;
+            written += n;
+        }
+        return written;
+    }
+
+    // Query lookup by C string: hasParam()/getParam() take a String key, which
+    // goes to the heap for names longer than the SSO buffer (e.g. "sensitivity")
+    static AsyncWebParameter *findParam(AsyncWebServerRequest *request, const char *name) {
+        size_t n = request->params();
+        for (size_t i = 0; i < n; i++) {
+            AsyncWebParameter *p = request->getParam(i);
+            if (!p->isPost() && !p->isFile() && p->name() == name) return p;
+        }
+        return nullptr;
+    }
+
+    static long paramInt(AsyncWebServerRequest *request, const char *name, long fallback) {
+        AsyncWebParameter *p = findParam(request, name);
+        return p ? p->value().toInt() : fallback;
+    }
+
+    // Per-client cap on full /data bodies (web task only)
+    struct DataClient {
+        uint32_t key;
+        unsigned long lastPoll;
+    };
+    static DataClient _dataClients[DATA_MAX_CLIENTS];
+
+    // Random per boot and part of every /data ETag: the cache sequence restarts
+    // at 0 on reboot, so a tag held from the previous run must not match
+    static uint32_t _bootTag;
+
+    // Apps sharing one address (several on a phone, or everything behind the
+    // Wokwi gateway) tell themselves apart with ?client=<id>; the remote IP is
+    // only the fallback
+    static uint32_t dataClientKey(AsyncWebServerRequest *request) {
+        AsyncWebParameter *id = findParam(request, "client");
+        if (!id) return (uint32_t)request->client()->remoteIP();
+        uint32_t h = 2166136261u; // FNV-1a
+        for (const char *c = id->value().c_str(); *c; c++) {
+            h ^= (uint8_t)*c;
+            h *= 16777619u;
+        }
+        return h;
+    }
+
+    // False if this client fetched a full body less than DATA_MIN_INTERVAL_MS ago
+    static bool admitDataPoll(uint32_t key, unsigned long now) {
+        DataClient *slot = &_dataClients[0];
+        for (int i = 0; i < DATA_MAX_CLIENTS; i++) {
+            if (_dataClients[i].key == key) {
+                if (now - _dataClients[i].lastPoll < DATA_MIN_INTERVAL_MS) return false;
+                slot = &_dataClients[i];
+                break;
+            }
+            // Otherwise take over the least recently seen entry
+            if (now - _dataClients[i].lastPoll > now - slot->lastPoll) slot = &_dataClients[i];
+        }
+        slot->key = key;
+        slot->lastPoll = now;
+        return true;
+    }
+
+    static bool etagMatches(AsyncWebServerRequest *request, const char *etag) {
+        size_t n = request->headers();
+        for (size_t i = 0; i < n; i++) {
+            AsyncWebHeader *h = request->getHeader(i);
+            if (strcasecmp(h->name().c_str(), "If-None-Match") == 0) return h->value() == etag;
+        }
+        return false;
+    }
+
 public:
     NetworkManager() : _server(80) {}
 
     void init() {
         WiFi.begin("Wokwi-GUEST", "", 6);
         while (WiFi.status() != WL_CONNECTED) { delay(500); }
+        _bootTag = esp_random(); // RF is up, so this is a true random number
+
+        // Every handler body runs inside an AllocScope, so the allocations each
+        // request costs, our code and the web server's together, are reported
+        // against its site. The floor the library imposes per request:
+        //  - the response object (beginResponse*/send)
+        //  - content-type / body Strings longer than the 10-char SSO buffer
+        //    ("application/json", "Config Queued for Main Loop", ...)
+        //  - each addHeader: an AsyncWebHeader, its list node and any long String
+        //  - /history: the std::function holding the captured stream state,
+        //    heap-allocated when it does not fit the small-object buffer, and the
+        //    buffer AsyncAbstractResponse::_ack mallocs for every chunk (taken
+        //    before the filler runs, so it is reported under "net")
+        // /mjpeg only pays this once per viewer. Its frames go out through
+        // mirrorPump(), where lwIP's own segment headers are the only allocations.
 
-        // video stream endpoint (for future use, not implemented in this code)
+        // Live mirror of the OLED (open in a browser <img> or any MJPEG-style viewer)
         _server.on("/mjpeg", HTTP_GET, [](AsyncWebServerRequest *request){
-            request->send(200, "multipart/x-mixed-replace; boundary=frame", "STREAM_DATA");
+            AllocScope scope(ALLOC_SITE_MIRROR);
+            int idx = -1;
+            for (int i = 0; i < MIRROR_MAX_CLIENTS && idx < 0; i++) {
+                if (!_mirrorClients[i].client) idx = i;
+            }
+            if (idx < 0) {
+                request->send(503, "text/plain", "Mirror Busy");
+                return;
+            }
+            // Reserved until the head is acked; give it back if the viewer leaves first
+            _mirrorClients[idx].client = request->client();
+            request->onDisconnect([idx]{ _mirrorClients[idx] = MirrorClient(); });
+            request->send(new MirrorResponse(idx));
         });
 
         // yolo feedback endpoint
         // Phone calls this: http://10.13.37.2
         _server.on("/yolo_feedback", HTTP_GET, [](AsyncWebServerRequest *request){
-            if (request->hasParam("detected")) {
-                bool detected = (request->getParam("detected")->value() == "1");
-                yoloVetoActive = !detected;
-                
-                // If it's a false positive, lock the distance
-                if (yoloVetoActive && globalTargetCount > 0) {
-                    lastVetoDistance = (float)activeTargets[0].distance;
-                    Serial.printf("YOLO VETO: Locked at %.1fm\n", lastVetoDistance);
+            AllocScope scope(ALLOC_SITE_YOLO);
+            AsyncWebParameter *detected = findParam(request, "detected");
+            if (detected) {
+                ControlCommand cmd;
+                cmd.type = CMD_VETO;
+                cmd.vetoActive = (detected->value() != "1");
+                if (!controlMailbox.push(cmd)) {
+                    request->send(503, "text/plain", "Mailbox Full");
+                    return;
                 }
             }
             request->send(200, "text/plain", "ACK");
         });
         
-        // Data endpoint for debugging/monitoring (returns JSON with current targets)
+        // Data endpoint for debugging/monitoring (returns JSON with current targets).
+        // The body is serialized once per frame by the main loop; pollers that send
+        // back the ETag get a body-less 304 until the next frame changes it.
         _server.on("/data", HTTP_GET, [](AsyncWebServerRequest *request){
-            int countSnapshot = globalTargetCount;
-            
-            String json;
-            json.reserve(256); 
-            
-            json = "{\"status\":\"online\",\"count\":";
-            json += String(countSnapshot);
-            json += ",\"targets\":[";
-            
-            for(int i = 0; i < countSnapshot; i++) {
-                json += "{\"id\":";
-                json += String(i);
-                json += ",\"dist\":";
-                json += String(activeTargets[i].distance);
-                json += "}";
-                if(i < countSnapshot - 1) json += ",";
+            AllocScope scope(ALLOC_SITE_DATA);
+            const char *body;
+            size_t len;
+            int slot;
+            char etag[20];
+            int status;
+            uint32_t seq = dataCache.acquire(body, len, slot);
+            snprintf(etag, sizeof(etag), "\"%08lx%08lx\"", (unsigned long)_bootTag, (unsigned long)seq);
+            // A 304 costs no body, so only full responses count against the cap
+            if (etagMatches(request, etag)) status = 304;
+            else if (!admitDataPoll(dataClientKey(request), millis())) status = 429;
+            else status = 200;
+
+            AsyncWebServerResponse *response;
+            if (status == 200) {
+                // The body is read from the slot as the TCP window allows, so keep
+                // it pinned until the connection goes away
+                request->onDisconnect([slot]{ dataCache.release(slot); });
+                // Use 'application/json' to help curl/apps parse it
+                response = request->beginResponse_P(200, "application/json", (const uint8_t *)body, len);
+            } else {
+                dataCache.release(slot);
+                response = request->beginResponse(status);
             }
-            json += "]}";
-            
-            // Use 'application/json' to help curl/apps parse it
-            request->send(200, "application/json", json);
+            if (status == 429) response->addHeader("Retry-After", "1");
+            else response->addHeader("ETag", etag);
+            response->addHeader("Cache-Control", "no-cache");
+            request->send(response);
         });
 
-        // Configuration endpoint to set radar parameters (range, direction to track (approaching/receding), sensitivity, min speed)
+        // Closest-target history for close-pass charts: [[time, dist, speed, angle, count], ...]
+        // since = device millis() to resume from (echoed back as "now"), step = downsampling in ms
+        _server.on("/history", HTTP_GET, [](AsyncWebServerRequest *request){
+            AllocScope scope(ALLOC_SITE_HISTORY);
+            HistoryStream st;
+            st.now = millis();
+            AsyncWebParameter *since = findParam(request, "since");
+            st.cursor.nextTime = since
+                ? (uint32_t)strtoul(since->value().c_str(), nullptr, 10)
+                : st.now - 0x7FFFFFFFu; // Everything still in the ring
+            uint32_t step = paramInt(request, "step", 0);
+            st.cursor.step = (step > HISTORY_PERIOD_MS) ? step : HISTORY_PERIOD_MS;
+
+            AsyncWebServerResponse *response = request->beginChunkedResponse("application/json",
+                [st](uint8_t *buffer, size_t maxLen, size_t index) mutable -> size_t {
+                    AllocScope scope(ALLOC_SITE_HISTORY);
+                    return fillHistory(st, buffer, maxLen);
+                });
+            request->send(response);
+        });
+
+        // Configuration endpoint to set radar parameters (range, direction to track (approaching/receding), sensitivity, min speed, report rate 10/20/50Hz)
         _server.on("/config", HTTP_GET, [](AsyncWebServerRequest *request){
+            AllocScope scope(ALLOC_SITE_CONFIG);
             // 1. Just harvest the data, do NOT use delay() or Serial2.write() here
-            nextRange  = request->hasParam("range") ? request->getParam("range")->value().toInt() : 100;
-            nextDir    = request->hasParam("direction") ? request->getParam("direction")->value().toInt() : 1;
-            nextMinSpd = request->hasParam("min_speed") ? request->getParam("min_speed")->value().toInt() : 5;
-            nextSens   = request->hasParam("sensitivity") ? request->getParam("sensitivity")->value().toInt() : 5;
-            
-            // 2. Set the flag for the main loop to handle
-            pendingConfigChange = true; 
+            ControlCommand cmd;
+            cmd.type = CMD_CONFIG;
+            cmd.config.range       = paramInt(request, "range", 100);
+            cmd.config.direction   = paramInt(request, "direction", 1);
+            cmd.config.minSpeed    = paramInt(request, "min_speed", 5);
+            cmd.config.sensitivity = paramInt(request, "sensitivity", 5);
+            cmd.config.rateHz      = radarRateFor(paramInt(request, "rate", 10));
+
+            // 2. Hand the whole set to the main loop in one message
+            if (!controlMailbox.push(cmd)) {
+                request->send(503, "text/plain", "Mailbox Full");
+                return;
+            }
             
             request->send(200, "text/plain", "Config Queued for Main Loop");
         });
 
         _server.on("/profile", HTTP_GET, [](AsyncWebServerRequest *request){
-            if (request->hasParam("side")) {
-                String side = request->getParam("side")->value();
-                currentTrafficSide = (side == "left") ? LEFT_HAND_DRIVE : RIGHT_HAND_DRIVE;
+            AllocScope scope(ALLOC_SITE_PROFILE);
+            bool queued = true;
+            AsyncWebParameter *side = findParam(request, "side");
+            if (side) {
+                ControlCommand cmd;
+                cmd.type = CMD_TRAFFIC_SIDE;
+                cmd.side = (side->value() == "left") ? LEFT_HAND_DRIVE : RIGHT_HAND_DRIVE;
+                queued = controlMailbox.push(cmd) && queued;
             }
 
-            if (request->hasParam("mode")) {
-                String mode = request->getParam("mode")->value();
-                if (mode == "city") {
-                    nextRange = 30; nextMinSpd = 10; nextSens = 3;
-                } else if (mode == "highway") {
-                    nextRange = 100; nextMinSpd = 5; nextSens = 8;
-                }
-                pendingConfigChange = true;
+            AsyncWebParameter *mode = findParam(request, "mode");
+            if (mode && (mode->value() == "city" || mode->value() == "highway")) {
+                ControlCommand cmd;
+                cmd.type = CMD_PROFILE;
+                cmd.profile = (mode->value() == "city") ? PROFILE_CITY : PROFILE_HIGHWAY;
+                queued = controlMailbox.push(cmd) && queued;
+            }
+
+            if (!queued) {
+                request->send(503, "text/plain", "Mailbox Full");
+                return;
             }
             request->send(200, "text/plain", "Profile Applied");
         });
@@ -115,4 +424,8 @@ public:
     bool isConnected() { return WiFi.status() == WL_CONNECTED; }
 };
 
+NetworkManager::MirrorClient NetworkManager::_mirrorClients[MIRROR_MAX_CLIENTS];
+NetworkManager::DataClient NetworkManager::_dataClients[DATA_MAX_CLIENTS];
+uint32_t NetworkManager::_bootTag = 0;
+
 #endif
\ No newline at end of file
@@ -12,6 +12,19 @@ const int CAM_LIGHT_PIN = 23;
 enum TrafficSide { LEFT_HAND_DRIVE, RIGHT_HAND_DRIVE };
 extern TrafficSide currentTrafficSide; // Declare it exists globally
 
+// Supported radar report rates. The UART stays at 115200 for all of them: a
+// full 5-target frame at 50Hz is ~1.9KB/s of the link's ~11.5KB/s.
+const uint8_t RADAR_RATES[] = {10, 20, 50};
+const int RADAR_RATE_COUNT = sizeof(RADAR_RATES) / sizeof(RADAR_RATES[0]);
+
+// Unknown rates fall back to the 10Hz power-on default
+inline uint8_t radarRateFor(uint8_t rateHz) {
+    for (int i = 0; i < RADAR_RATE_COUNT; i++) {
+        if (RADAR_RATES[i] == rateHz) return rateHz;
+    }
+    return RADAR_RATES[0];
+}
+
 struct RadarTarget {
     uint8_t angle;      // 0-255 (128 is center)
     uint8_t distance;   // 0-100m
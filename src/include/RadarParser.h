@@ -3,22 +3,29 @@
 
 #include "RadarConfig.h"
 
+#define RADAR_MAX_PAYLOAD 64 // Count + type + up to 12 five-byte targets
+#define RADAR_MAX_ACK 16     // Command word, status and any ACK data
+
 class RadarParser {
-public:
-    static int parse(HardwareSerial &ser, RadarTarget *targets, int maxTargets) {
-        if (ser.available() < 12) return 0;
-        
+private:
+    // Decodes a single frame, returns -1 if the bytes consumed were not a frame
+    static int parseFrame(Stream &ser, RadarTarget *targets, int maxTargets) {
         if (ser.read() == 0xF4) {
             uint8_t h[3]; ser.readBytes(h, 3);
             if (h[0] == 0xF3 && h[1] == 0xF2 && h[2] == 0xF1) {
-                uint16_t dataLen;
+                uint16_t dataLen = 0;
                 ser.readBytes((uint8_t*)&dataLen, 2);
-                uint8_t payload[dataLen];
+                // Length comes off the wire: a corrupt value just drops the frame
+                // and the next call resyncs on the header
+                if (dataLen < 2 || dataLen > RADAR_MAX_PAYLOAD) return -1;
+                uint8_t payload[RADAR_MAX_PAYLOAD];
                 ser.readBytes(payload, dataLen);
                 uint8_t footer[4];
                 ser.readBytes(footer, 4);
 
                 int count = payload[0];
+                int inPayload = (dataLen - 2) / 5;
+                if (count > inPayload) count = inPayload;
                 int actualToRead = (count > maxTargets) ? maxTargets : count;
 
                 for (int i = 0; i < actualToRead; i++) {
@@ -33,7 +40,54 @@ public:
                 return actualToRead;
             }
         }
-        return 0;
+        return -1;
+    }
+
+public:
+    // Drains every complete frame waiting in the UART and keeps the newest one,
+    // so a slow loop iteration never leaves the parser behind at 20/50Hz
+    static int parse(Stream &ser, RadarTarget *targets, int maxTargets, int *framesDecoded = nullptr) {
+        int latest = 0;
+        int frames = 0;
+        while (ser.available() >= 12) {
+            int count = parseFrame(ser, targets, maxTargets);
+            if (count >= 0) {
+                latest = count;
+                frames++;
+            }
+        }
+        if (framesDecoded) *framesDecoded = frames;
+        return latest;
+    }
+
+    // Scans what the radar has sent back for the ACK of a config command
+    // (0xFD 0xFC 0xFB 0xFA, length, cmd | 0x0100, status, footer) and returns
+    // true if it reports success. Anything else in the buffer is dropped.
+    static bool readAck(Stream &ser, uint16_t cmd) {
+        static const uint8_t HEADER[4] = {0xFD, 0xFC, 0xFB, 0xFA};
+        int matched = 0;
+        while (ser.available() > 0) {
+            uint8_t b = ser.read();
+            if (b != HEADER[matched]) {
+                matched = (b == HEADER[0]) ? 1 : 0;
+                continue;
+            }
+            if (++matched < 4) continue;
+            matched = 0;
+
+            uint16_t len = 0;
+            ser.readBytes((uint8_t*)&len, 2);
+            if (len < 4 || len > RADAR_MAX_ACK) continue;
+            uint8_t body[RADAR_MAX_ACK];
+            ser.readBytes(body, len);
+            uint8_t footer[4];
+            ser.readBytes(footer, 4);
+            if (footer[0] != 0x04 || footer[1] != 0x03 || footer[2] != 0x02 || footer[3] != 0x01) continue;
+
+            uint16_t ackCmd = body[0] | (body[1] << 8);
+            if (ackCmd == (cmd | 0x0100)) return body[2] == 0 && body[3] == 0;
+        }
+        return false;
     }
 };
 
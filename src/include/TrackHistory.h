@@ -0,0 +1,160 @@
+#ifndef TRACK_HISTORY_H
+#define TRACK_HISTORY_H
+
+#include <atomic>
+#include "RadarConfig.h"
+
+#define HISTORY_PERIOD_MS 100   // Record the closest target at most at 10Hz
+#define HISTORY_BLOCK_SAMPLES 64
+#define HISTORY_BLOCKS 16       // 1024 samples (~100s of traffic) in ~5KB
+#define HISTORY_DT_UNIT_MS 4    // Time column resolution
+
+// One decoded history row
+struct HistorySample {
+    uint32_t time;     // millis() when recorded
+    uint8_t distance;  // Closest target
+    uint8_t speed;
+    uint8_t angle;
+    uint8_t count;     // Targets in the frame
+};
+
+// Read position of a /history stream, kept per connection
+struct HistoryCursor {
+    uint32_t nextTime = 0; // Next row must be at or after this timestamp
+    uint32_t step = 0;     // Downsampling interval in ms
+    int block = -1;        // Block the last row came from, -1 = scan from the oldest
+    uint32_t blockEpoch = 0;
+};
+
+// Fixed-memory ring of closest-target samples, only written while cars are seen.
+// Samples live in 64-row blocks; each block keeps absolute values for its first
+// row and stores every later row as int8 deltas in separate columns. A delta that
+// does not fit (or a long gap) just starts the next block, evicting the oldest.
+class TrackHistory {
+private:
+    struct Block {
+        std::atomic<uint32_t> epoch; // Odd while the block is being recycled
+        std::atomic<uint8_t> size;   // Rows published to readers
+        uint32_t startTime;
+        uint8_t startDist, startSpeed, startAngle;
+        uint8_t dt[HISTORY_BLOCK_SAMPLES];      // Since previous row, in HISTORY_DT_UNIT_MS
+        int8_t dDist[HISTORY_BLOCK_SAMPLES];
+        int8_t dSpeed[HISTORY_BLOCK_SAMPLES];
+        int8_t dAngle[HISTORY_BLOCK_SAMPLES];
+        uint8_t count[HISTORY_BLOCK_SAMPLES];
+    };
+
+    Block _blocks[HISTORY_BLOCKS];
+    std::atomic<int> _head; // Block currently being appended to
+    uint32_t _lastTime = 0;
+    uint8_t _lastDist = 0, _lastSpeed = 0, _lastAngle = 0;
+
+    static bool fitsDelta(int d) { return d >= -128 && d <= 127; }
+
+    void startBlock(uint32_t now, uint8_t dist, uint8_t speed, uint8_t angle, uint8_t count) {
+        int head = (_head.load(std::memory_order_relaxed) + 1) % HISTORY_BLOCKS;
+        Block &b = _blocks[head];
+        b.epoch.fetch_add(1, std::memory_order_acq_rel);
+        b.size.store(0, std::memory_order_relaxed);
+        b.startTime = now;
+        b.startDist = dist; b.startSpeed = speed; b.startAngle = angle;
+        b.dt[0] = 0; b.dDist[0] = 0; b.dSpeed[0] = 0; b.dAngle[0] = 0;
+        b.count[0] = count;
+        b.epoch.fetch_add(1, std::memory_order_release);
+        b.size.store(1, std::memory_order_release);
+        _head.store(head, std::memory_order_release);
+    }
+
+    static void applyRow(const Block &b, int i, HistorySample &s) {
+        if (i == 0) {
+            s.time = b.startTime;
+            s.distance = b.startDist; s.speed = b.startSpeed; s.angle = b.startAngle;
+        } else {
+            s.time += b.dt[i] * HISTORY_DT_UNIT_MS;
+            s.distance += b.dDist[i]; s.speed += b.dSpeed[i]; s.angle += b.dAngle[i];
+        }
+        s.count = b.count[i];
+    }
+
+public:
+    TrackHistory() : _head(0) {
+        for (int i = 0; i < HISTORY_BLOCKS; i++) {
+            _blocks[i].epoch.store(0, std::memory_order_relaxed);
+            _blocks[i].size.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    // Called from loop() on every decoded frame with targets; decimates itself
+    void record(uint32_t now, const RadarTarget *targets, int count) {
+        if (count <= 0) return;
+        Block &b = _blocks[_head.load(std::memory_order_relaxed)];
+        uint8_t n = b.size.load(std::memory_order_relaxed);
+        if (n > 0 && now - _lastTime < HISTORY_PERIOD_MS) return;
+
+        const RadarTarget *closest = &targets[0];
+        for (int i = 1; i < count; i++) {
+            if (targets[i].distance < closest->distance) closest = &targets[i];
+        }
+
+        uint32_t dtUnits = (now - _lastTime) / HISTORY_DT_UNIT_MS;
+        int dDist = (int)closest->distance - _lastDist;
+        int dSpeed = (int)closest->speed - _lastSpeed;
+        int dAngle = (int)closest->angle - _lastAngle;
+
+        if (n == 0 || n >= HISTORY_BLOCK_SAMPLES || dtUnits > 255 ||
+            !fitsDelta(dDist) || !fitsDelta(dSpeed) || !fitsDelta(dAngle)) {
+            startBlock(now, closest->distance, closest->speed, closest->angle, (uint8_t)count);
+            _lastTime = now;
+        } else {
+            b.dt[n] = (uint8_t)dtUnits;
+            b.dDist[n] = (int8_t)dDist;
+            b.dSpeed[n] = (int8_t)dSpeed;
+            b.dAngle[n] = (int8_t)dAngle;
+            b.count[n] = (uint8_t)count;
+            b.size.store(n + 1, std::memory_order_release);
+            // Keep the time base on the quantised value so rounding never accumulates
+            _lastTime += dtUnits * HISTORY_DT_UNIT_MS;
+        }
+        _lastDist = closest->distance;
+        _lastSpeed = closest->speed;
+        _lastAngle = closest->angle;
+    }
+
+    // Next row at or after cursor.nextTime, oldest first. Safe to call from the
+    // web task: rows from a block recycled mid-read are discarded, never torn.
+    bool next(HistoryCursor &cursor, HistorySample &out) {
+        int head = _head.load(std::memory_order_acquire);
+        int first = (head + 1) % HISTORY_BLOCKS;
+        if (cursor.block >= 0 &&
+            _blocks[cursor.block].epoch.load(std::memory_order_acquire) == cursor.blockEpoch) {
+            first = cursor.block;
+        }
+
+        for (int k = 0, bi = first; k < HISTORY_BLOCKS; k++, bi = (bi + 1) % HISTORY_BLOCKS) {
+            const Block &b = _blocks[bi];
+            uint32_t epoch = b.epoch.load(std::memory_order_acquire);
+            if (epoch & 1) continue;
+            uint8_t n = b.size.load(std::memory_order_acquire);
+
+            HistorySample s;
+            for (int i = 0; i < n; i++) {
+                applyRow(b, i, s); // Rows are deltas, so decode them in order
+                if ((int32_t)(s.time - cursor.nextTime) < 0) continue;
+                // Seqlock re-check: the fence keeps the plain reads of startTime
+                // and the delta columns above from moving past the epoch load
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (b.epoch.load(std::memory_order_relaxed) != epoch) break;
+
+                out = s;
+                cursor.nextTime = s.time + (cursor.step > 0 ? cursor.step : 1);
+                cursor.block = bi;
+                cursor.blockEpoch = epoch;
+                return true;
+            }
+            if (bi == head) break; // Reached the newest block
+        }
+        return false;
+    }
+};
+
+#endif
@@ -4,6 +4,10 @@
 #include "include/DisplayModule.h"
 #include "include/NetworkManager.h"
 #include "include/FilterModule.h" 
+#include "include/ControlMailbox.h"
+#include "include/TrackHistory.h"
+#include "include/AllocTrace.h"
+#include "include/DataCache.h"
 
 SignalFilter radarFilter;
 
@@ -12,13 +16,20 @@ RadarTarget activeTargets[5];
 SafetySystems safety;
 DisplayModule ui;
 NetworkManager network;
+TrackHistory trackHistory;
+DataCache dataCache;
 volatile int globalTargetCount = 0;
 unsigned long lastValidRadarTime = 0;
 const int DATA_PERSIST_MS = 250;
+
+// Commands from the web handlers, drained once at the top of every loop().
+// Everything below is only ever touched by the main loop.
+ControlMailbox<16> controlMailbox;
 bool yoloVetoActive = false;
-volatile float lastVetoDistance = 0.0f;
+float lastVetoDistance = 0.0f;
 bool pendingConfigChange = false;
-uint8_t nextRange, nextDir, nextMinSpd, nextSens;
+RadarSettings radarSettings = {100, 1, 5, 5, 10};
+uint8_t linkRate = 10;  // Report rate the radar last acknowledged
 
 TrafficSide currentTrafficSide = RIGHT_HAND_DRIVE;
 
@@ -27,17 +38,67 @@ unsigned long lastCarSeenTime = 0;
 const int CLEAR_TIMEOUT = 500;
 bool alreadyClear = false;
 
+// The OLED push takes ~25ms over I2C, so at 20/50Hz the screen is refreshed
+// at a capped rate while parsing, filtering and safety run on every frame
+const int DISPLAY_MIN_INTERVAL_MS = 40;
+unsigned long lastRenderTime = 0;
+
+// Link throughput stats, printed periodically as proof the loop keeps up
+const int LINK_STATS_MS = 5000;
+unsigned long linkStatsStart = 0;
+uint32_t linkFrames = 0;
+uint32_t linkMaxLoopUs = 0;
+
 void setup() {
     Serial.begin(115200);
+    Serial2.setRxBufferSize(1024);
     Serial2.begin(115200, SERIAL_8N1, RAD_RX, RAD_TX);
     
     safety.init();
     ui.init();
     network.init();
     Serial.println("Safebaige Modular Boot Complete");
+    AllocTrace::arm(); // Steady state from here on: loop() must not touch the heap
+    linkStatsStart = millis(); // First stats window leaves out WiFi connect and boot
+}
+
+void drainControlMailbox() {
+    ControlCommand cmd;
+    while (controlMailbox.pop(cmd)) {
+        switch (cmd.type) {
+            case CMD_CONFIG:
+                radarSettings = cmd.config;
+                pendingConfigChange = true;
+                break;
+
+            case CMD_PROFILE:
+                if (cmd.profile == PROFILE_CITY) {
+                    radarSettings.range = 30; radarSettings.minSpeed = 10; radarSettings.sensitivity = 3;
+                } else {
+                    radarSettings.range = 100; radarSettings.minSpeed = 5; radarSettings.sensitivity = 8;
+                }
+                pendingConfigChange = true;
+                break;
+
+            case CMD_VETO:
+                yoloVetoActive = cmd.vetoActive;
+                // If it's a false positive, lock the distance
+                if (yoloVetoActive && globalTargetCount > 0) {
+                    lastVetoDistance = (float)activeTargets[0].distance;
+                    Serial.printf("YOLO VETO: Locked at %um\n", activeTargets[0].distance);
+                }
+                break;
+
+            case CMD_TRAFFIC_SIDE:
+                currentTrafficSide = cmd.side;
+                break;
+        }
+    }
 }
 
 void loop() {
+    drainControlMailbox();
+
   // Check if there's a pending radar configuration change from the web interface
     if (pendingConfigChange) {
         Serial.println("[MAIN] Executing Radar Re-config...");
@@ -48,18 +109,50 @@ void loop() {
         delay(150);
 
         // Set Params (0x0002)
-        uint8_t params[] = {0xFD, 0xFC, 0xFB, 0xFA, 0x06, 0x00, 0x02, 0x00, nextRange, nextDir, nextMinSpd, 0x01, 0x04, 0x03, 0x02, 0x01};
+        uint8_t params[] = {0xFD, 0xFC, 0xFB, 0xFA, 0x06, 0x00, 0x02, 0x00, radarSettings.range, radarSettings.direction, radarSettings.minSpeed, 0x01, 0x04, 0x03, 0x02, 0x01};
         Serial2.write(params, sizeof(params));
         delay(150);
 
+        uint8_t rateHz = radarRateFor(radarSettings.rateHz);
+        bool rateAcked = false;
+        if (rateHz != linkRate) {
+            // Set Report Period (0x0010), in ms
+            uint16_t periodMs = 1000 / rateHz;
+            uint8_t period[] = {0xFD, 0xFC, 0xFB, 0xFA, 0x04, 0x00, 0x10, 0x00,
+                                (uint8_t)(periodMs & 0xFF), (uint8_t)(periodMs >> 8), 0x04, 0x03, 0x02, 0x01};
+            Serial2.write(period, sizeof(period));
+            delay(150);
+            rateAcked = RadarParser::readAck(Serial2, 0x0010);
+        }
+
         // End Config Sequence
         uint8_t end[] = {0xFD, 0xFC, 0xFB, 0xFA, 0x02, 0x00, 0xFE, 0x00, 0x04, 0x03, 0x02, 0x01};
         Serial2.write(end, sizeof(end));
 
+        if (rateHz != linkRate) {
+            // Only report a rate the radar has confirmed (an emulator .wasm built
+            // before 0x0010 never answers and keeps sending at 10Hz)
+            if (rateAcked) {
+                linkRate = rateHz;
+                Serial.printf("[MAIN] Radar link -> %dHz\n", linkRate);
+            } else {
+                Serial.printf("[MAIN] Radar did not acknowledge %dHz, staying at %dHz\n", rateHz, linkRate);
+            }
+        }
+
         pendingConfigChange = false; // Reset the flag
         Serial.println("[MAIN] Config Sequence Finished.");
+
+        // The re-config delays (and possibly a new rate) would skew the
+        // current stats window, so start a fresh one
+        linkStatsStart = millis();
+        linkFrames = 0;
+        linkMaxLoopUs = 0;
     }
-    int count = RadarParser::parse(Serial2, activeTargets, 5);
+    unsigned long loopStartUs = micros(); // Re-config delays are left out of the stats
+    int frames = 0;
+    int count = RadarParser::parse(Serial2, activeTargets, 5, &frames);
+    linkFrames += frames;
     bool phoneAttached = network.isConnected();
     bool cameraRecording = safety.isRecording();
 
@@ -72,14 +165,19 @@ void loop() {
         for(int i = 0; i < count; i++) {
             activeTargets[i].distance = radarFilter.smooth(i, activeTargets[i].distance);
         }
+        trackHistory.record(millis(), activeTargets, count);
+        dataCache.publish(count, activeTargets);
 
         if (yoloVetoActive && abs(closest - lastVetoDistance) > 5) {
             yoloVetoActive = false; 
             Serial.println("YOLO: New target detected. Resetting Veto.");
         }
 
-        ui.render(count, activeTargets, network.isConnected(), safety.isRecording());
         safety.update(true, closest, yoloVetoActive);
+        if (millis() - lastRenderTime >= DISPLAY_MIN_INTERVAL_MS) {
+            ui.render(count, activeTargets, network.isConnected(), safety.isRecording());
+            lastRenderTime = millis();
+        }
     } 
     else {
       if (millis() - lastCarSeenTime > DATA_PERSIST_MS) {
@@ -88,6 +186,7 @@ void loop() {
           safety.update(false, 100, yoloVetoActive); 
           
           if (!alreadyClear) {
+              dataCache.publish(0, activeTargets);
               ui.showClear(phoneAttached);
               alreadyClear = true;
               yoloVetoActive = false; // Reset veto when road is clear
@@ -95,4 +194,19 @@ void loop() {
           for(int i=0; i<5; i++) radarFilter.reset(i);
       }
     }
+
+    uint32_t loopUs = micros() - loopStartUs;
+    if (loopUs > linkMaxLoopUs) linkMaxLoopUs = loopUs;
+    unsigned long linkElapsedMs = millis() - linkStatsStart;
+    if (linkElapsedMs >= LINK_STATS_MS) {
+        // Integer formatting only: newlib's float printf allocates on first use
+        uint32_t tenthsPerSec = linkFrames * 10000UL / linkElapsedMs;
+        Serial.printf("[LINK] %dHz: %lu.%lu frames/s, max loop %luus\n", linkRate,
+                      (unsigned long)(tenthsPerSec / 10), (unsigned long)(tenthsPerSec % 10), (unsigned long)linkMaxLoopUs);
+        AllocTrace::report(Serial);
+        linkStatsStart = millis();
+        linkFrames = 0;
+        linkMaxLoopUs = 0;
+    }
+    AllocTrace::check();
 }
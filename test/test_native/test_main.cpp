@@ -0,0 +1,310 @@
+// Native (host) tests for the header-only hot-path modules: every path loop()
+// or a web handler runs per frame must not touch the heap. Build with
+// `pio test -e native`; the env links with --wrap=malloc/calloc/realloc/free
+// (GNU ld) so the wrappers below see every allocation made from this binary.
+
+#include <Arduino.h>
+#include <unity.h>
+#include <new>
+#include "RadarParser.h"
+#include "ControlMailbox.h"
+#include "TrackHistory.h"
+#include "DataCache.h"
+#include "MirrorCache.h"
+
+static bool tracking = false;
+static unsigned allocations = 0;
+
+extern "C" {
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t n, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+void __real_free(void *ptr);
+
+void *__wrap_malloc(size_t size) {
+    if (tracking) allocations++;
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t n, size_t size) {
+    if (tracking) allocations++;
+    return __real_calloc(n, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size) {
+    if (tracking) allocations++;
+    return __real_realloc(ptr, size);
+}
+
+void __wrap_free(void *ptr) {
+    __real_free(ptr);
+}
+}
+
+// libstdc++'s operator new calls malloc from inside the shared library, out of
+// reach of --wrap, so route it through the wrapped symbol here
+void *operator new(size_t size) {
+    void *p = malloc(size);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+void operator delete(void *p) noexcept { free(p); }
+void operator delete(void *p, size_t) noexcept { free(p); }
+
+static void startTracking() {
+    allocations = 0;
+    tracking = true;
+}
+
+static unsigned stopTracking() {
+    tracking = false;
+    return allocations;
+}
+
+// Replays a byte buffer as a UART
+class MemStream : public Stream {
+private:
+    const uint8_t *_data;
+    size_t _len;
+    size_t _pos = 0;
+
+public:
+    MemStream(const uint8_t *data, size_t len) : _data(data), _len(len) {}
+    int available() override { return (int)(_len - _pos); }
+    int read() override { return (_pos < _len) ? _data[_pos++] : -1; }
+};
+
+// Frame as the radar (and radarchipemu) sends it: header, length, count, type,
+// five bytes per target, footer
+static size_t buildFrame(uint8_t *out, const RadarTarget *targets, int count, uint16_t dataLen = 0) {
+    size_t i = 0;
+    if (dataLen == 0) dataLen = count * 5 + 2;
+    out[i++] = 0xF4; out[i++] = 0xF3; out[i++] = 0xF2; out[i++] = 0xF1;
+    out[i++] = dataLen & 0xFF; out[i++] = dataLen >> 8;
+    out[i++] = (uint8_t)count;
+    out[i++] = 0x01;
+    for (int t = 0; t < count; t++) {
+        out[i++] = targets[t].angle;
+        out[i++] = targets[t].distance;
+        out[i++] = targets[t].approaching ? 0x01 : 0x00;
+        out[i++] = targets[t].speed;
+        out[i++] = targets[t].snr;
+    }
+    out[i++] = 0xF8; out[i++] = 0xF7; out[i++] = 0xF6; out[i++] = 0xF5;
+    return i;
+}
+
+void setUp() {}
+void tearDown() {}
+
+// The wrappers must actually be linked in, or every other test passes vacuously
+void test_tracer_counts_allocations() {
+    startTracking();
+    void *volatile p = malloc(16);
+    free(p);
+    int *volatile q = new int(1);
+    delete q;
+    TEST_ASSERT_EQUAL_UINT(2, stopTracking());
+}
+
+void test_parser_decodes_without_allocating() {
+    RadarTarget sent[3] = {{128, 40, true, 30, 170}, {120, 25, true, 45, 200}, {90, 8, true, 20, 240}};
+    uint8_t wire[256];
+    size_t len = buildFrame(wire, sent, 2);
+    len += buildFrame(wire + len, sent, 1, 200); // Corrupt length, dropped
+    len += buildFrame(wire + len, sent, 3);
+
+    MemStream ser(wire, len);
+    RadarTarget got[5];
+    int frames = 0;
+    startTracking();
+    int count = RadarParser::parse(ser, got, 5, &frames);
+    TEST_ASSERT_EQUAL_UINT(0, stopTracking());
+
+    TEST_ASSERT_EQUAL_INT(3, count);
+    TEST_ASSERT_EQUAL_INT(2, frames);
+    TEST_ASSERT_EQUAL_UINT8(8, got[2].distance);
+    TEST_ASSERT_EQUAL_UINT8(90, got[2].angle);
+    TEST_ASSERT_TRUE(got[2].approaching);
+}
+
+// What the emulator answers to 0x0010, behind a stray data byte and the ACK of another command
+void test_parser_reads_config_ack() {
+    const uint8_t wire[] = {
+        0x55,
+        0xFD, 0xFC, 0xFB, 0xFA, 0x08, 0x00, 0xFF, 0x01, 0x00, 0x00, 0x01, 0x00, 0x40, 0x00, 0x04, 0x03, 0x02, 0x01,
+        0xFD, 0xFC, 0xFB, 0xFA, 0x04, 0x00, 0x10, 0x01, 0x00, 0x00, 0x04, 0x03, 0x02, 0x01,
+    };
+    MemStream ok(wire, sizeof(wire));
+    TEST_ASSERT_TRUE(RadarParser::readAck(ok, 0x0010));
+
+    uint8_t rejected[sizeof(wire)];
+    memcpy(rejected, wire, sizeof(wire));
+    rejected[sizeof(wire) - 6] = 0x01; // Status word
+    MemStream nak(rejected, sizeof(rejected));
+    TEST_ASSERT_FALSE(RadarParser::readAck(nak, 0x0010));
+
+    // A radar that ignores the command sends nothing back
+    MemStream silent(wire, 19);
+    TEST_ASSERT_FALSE(RadarParser::readAck(silent, 0x0010));
+}
+
+void test_mailbox_push_pop_without_allocating() {
+    static ControlMailbox<16> mailbox;
+    ControlCommand cmd;
+    cmd.type = CMD_CONFIG;
+    cmd.config = {100, 1, 5, 5, 50};
+
+    ControlCommand out;
+    int pushed = 0, popped = 0;
+    startTracking();
+    while (mailbox.push(cmd)) pushed++;
+    while (mailbox.pop(out)) popped++;
+    TEST_ASSERT_EQUAL_UINT(0, stopTracking());
+
+    TEST_ASSERT_EQUAL_INT(16, pushed);
+    TEST_ASSERT_EQUAL_INT(16, popped);
+    TEST_ASSERT_EQUAL_UINT8(50, out.config.rateHz);
+}
+
+void test_history_record_next_without_allocating() {
+    static TrackHistory history;
+    RadarTarget targets[2] = {{128, 60, true, 40, 150}, {128, 80, true, 40, 150}};
+    HistoryCursor cursor;
+    cursor.nextTime = 0;
+    cursor.step = HISTORY_PERIOD_MS;
+    HistorySample s;
+    int rows = 0;
+
+    startTracking();
+    // 2000 rows (one per 100ms over 200s) wrap the 1024-row ring, so blocks get
+    // recycled as well as appended to
+    for (uint32_t t = 1; t <= 10000; t++) {
+        targets[0].distance = (uint8_t)(60 - (t % 50));
+        history.record(t * 20, targets, 2);
+    }
+    while (history.next(cursor, s)) rows++;
+    TEST_ASSERT_EQUAL_UINT(0, stopTracking());
+
+    // Fifteen full blocks plus the 2000 % 64 rows of the one being appended to
+    TEST_ASSERT_EQUAL_INT((HISTORY_BLOCKS - 1) * HISTORY_BLOCK_SAMPLES + 2000 % HISTORY_BLOCK_SAMPLES, rows);
+    TEST_ASSERT_EQUAL_UINT32(199920, s.time);
+    TEST_ASSERT_EQUAL_UINT8(2, s.count);
+}
+
+void test_data_cache_publish_without_allocating() {
+    static DataCache cache;
+    RadarTarget targets[5] = {{128, 40, true, 30, 170}, {128, 55, true, 30, 170}};
+    const char *body;
+    size_t len;
+    int slot;
+
+    uint32_t first = cache.acquire(body, len, slot);
+    cache.release(slot);
+    startTracking();
+    for (int i = 0; i < 100; i++) {
+        targets[0].distance = (uint8_t)(40 - (i % 30));
+        cache.publish(2, targets);
+    }
+    cache.publish(2, targets); // Unchanged body, same sequence
+    uint32_t seq = cache.acquire(body, len, slot);
+    cache.release(slot);
+    TEST_ASSERT_EQUAL_UINT(0, stopTracking());
+
+    TEST_ASSERT_EQUAL_UINT32(first + 100, seq);
+    TEST_ASSERT_EQUAL_STRING_LEN("{\"status\":\"online\",\"count\":2,\"targets\":[{\"id\":0,\"dist\":31},{\"id\":1,\"dist\":55}]}",
+                                 body, len);
+}
+
+// A body still being sent must survive any number of newer frames
+void test_data_cache_keeps_pinned_slots() {
+    static DataCache cache;
+    RadarTarget targets[1] = {{128, 90, true, 30, 170}};
+    const char *body[DATA_CACHE_SLOTS];
+    size_t len[DATA_CACHE_SLOTS];
+    int slot[DATA_CACHE_SLOTS];
+    char copy[DATA_CACHE_BYTES];
+
+    cache.publish(1, targets);
+    uint32_t seq = cache.acquire(body[0], len[0], slot[0]);
+    memcpy(copy, body[0], len[0]);
+    for (int i = 0; i < 10; i++) {
+        targets[0].distance = (uint8_t)(80 - i);
+        cache.publish(1, targets);
+    }
+    TEST_ASSERT_EQUAL_STRING_LEN(copy, body[0], len[0]);
+
+    // Pin every slot: publish() has nowhere to write and keeps the current body
+    for (int i = 1; i < DATA_CACHE_SLOTS; i++) {
+        cache.acquire(body[i], len[i], slot[i]);
+        targets[0].distance = (uint8_t)(50 - i);
+        cache.publish(1, targets);
+    }
+    uint32_t stalled = cache.acquire(body[0], len[0], slot[0]);
+    cache.release(slot[0]);
+    targets[0].distance = 20;
+    cache.publish(1, targets);
+    const char *latest;
+    size_t latestLen;
+    int latestSlot;
+    TEST_ASSERT_EQUAL_UINT32(stalled, cache.acquire(latest, latestLen, latestSlot));
+    cache.release(latestSlot);
+    TEST_ASSERT_TRUE(stalled > seq + 10);
+
+    // Releasing a pin lets the next frame through
+    for (int i = 0; i < DATA_CACHE_SLOTS; i++) cache.release(slot[i]);
+    cache.publish(1, targets);
+    TEST_ASSERT_EQUAL_UINT32(stalled + 1, cache.acquire(latest, latestLen, latestSlot));
+    cache.release(latestSlot);
+}
+
+// Part layout and the page -> BMP transpose, built without touching the heap
+void test_mirror_publishes_bmp_parts_without_allocating() {
+    static MirrorCache cache;
+    static uint8_t fb[MIRROR_FRAME_BYTES];
+    int slot;
+
+    uint32_t first = cache.acquire(slot);
+    cache.release(slot);
+    fb[0] = 0x01;                                  // Pixel (0, 0): top left
+    fb[MIRROR_FRAME_BYTES - 1] = 0x80;             // Pixel (127, 63): bottom right
+    startTracking();
+    cache.publish(fb);
+    cache.publish(fb); // Same picture, same sequence
+    uint32_t seq = cache.acquire(slot);
+    TEST_ASSERT_EQUAL_UINT(0, stopTracking());
+
+    TEST_ASSERT_EQUAL_UINT32(first + 1, seq);
+    const uint8_t *part = cache.part(slot);
+    TEST_ASSERT_EQUAL_INT(0, memcmp(part, MIRROR_PART_HEADER, MIRROR_PART_HEADER_LEN));
+    TEST_ASSERT_EQUAL_UINT8('B', part[MIRROR_PART_HEADER_LEN]);
+    const uint8_t *px = part + MIRROR_PIXELS_OFFSET;
+    // BMP rows run bottom-up, leftmost pixel in the MSB
+    TEST_ASSERT_EQUAL_UINT8(0x01, px[MIRROR_WIDTH / 8 - 1]);                  // Bottom right
+    TEST_ASSERT_EQUAL_UINT8(0x80, px[MIRROR_FRAME_BYTES - MIRROR_WIDTH / 8]); // Top left
+    TEST_ASSERT_EQUAL_UINT8('\r', part[MIRROR_PART_LEN - 2]);
+    TEST_ASSERT_EQUAL_UINT8('\n', part[MIRROR_PART_LEN - 1]);
+
+    // A part lwIP still references survives newer frames
+    uint8_t copy[MIRROR_FRAME_BYTES];
+    memcpy(copy, px, MIRROR_FRAME_BYTES);
+    for (int i = 1; i < 20; i++) {
+        fb[i] = 0xFF;
+        cache.publish(fb);
+    }
+    TEST_ASSERT_EQUAL_INT(0, memcmp(copy, px, MIRROR_FRAME_BYTES));
+    cache.release(slot);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_tracer_counts_allocations);
+    RUN_TEST(test_parser_decodes_without_allocating);
+    RUN_TEST(test_parser_reads_config_ack);
+    RUN_TEST(test_mailbox_push_pop_without_allocating);
+    RUN_TEST(test_history_record_next_without_allocating);
+    RUN_TEST(test_data_cache_publish_without_allocating);
+    RUN_TEST(test_data_cache_keeps_pinned_slots);
+    RUN_TEST(test_mirror_publishes_bmp_parts_without_allocating);
+    return UNITY_END();
+}